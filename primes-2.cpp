@@ -1,7 +1,8 @@
 #include <stdio.h>
 #include <mpi.h>
 #include <math.h>
-#include <vector>
+#include <sched.h>
+#include <sys/mman.h>
 
 // Debug mode. Comment next line to disable it. Uncomment to enable.
 //#define DEBUG
@@ -75,6 +76,20 @@ int RANK;
 //
 ////////////////////////////////////////////////
 
+////////////////////////////////////////////////
+// Placement
+
+// Pinning nodes to cores. Comment next line to disable it. Uncomment to enable.
+#define PIN_NODES
+
+// Huge pages for big buffers. Transparent huge pages are requested by default.
+// Uncomment next line to use explicitly reserved ones (vm.nr_hugepages), with fallback to transparent.
+//#define HUGE_PAGES_EXPLICIT
+#define HUGE_PAGE_SIZE (2LLU << 20)
+
+//
+////////////////////////////////////////////////
+
 // Num data type.
 typedef unsigned long long int num;
 
@@ -101,6 +116,114 @@ bool isPrime(num n) {
  return true;
 }
 
+// Pins calling node to a single core, so it doesn't migrate between cores (and sockets) and memory it
+// touches first stays on its local NUMA node. The launcher may already bind nodes to a socket or NUMA
+// node, so nodes with the same allowed set of cores take consecutive cores of it. A node bound to one
+// core by the launcher is left as it is. Returns the core or -1 if pinning is not possible.
+int pinNode() {
+#ifdef __linux__
+ cpu_set_t allowed;
+ int cpus = 0, firstCpu = -1;
+
+ if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+  cpus = CPU_COUNT(&allowed);
+  for (int cpu = 0; cpu < CPU_SETSIZE && firstCpu < 0; ++cpu) {
+   if (CPU_ISSET(cpu, &allowed)) firstCpu = cpu;
+  }
+ }
+
+ // Nodes of this host with the same allowed set (told apart by its first core and size).
+ MPI_Comm hostComm, setComm;
+ int setRank = 0;
+#if MPI_VERSION >= 3
+ MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &hostComm);
+#else
+ // MPI-2 (e.g. Open MPI 1.6) has no shared memory split, hosts are told apart by a hash of their name.
+ char hostName[MPI_MAX_PROCESSOR_NAME];
+ int hostNameLen;
+ unsigned int hostHash = 5381;
+ MPI_Get_processor_name(hostName, &hostNameLen);
+ for (int i = 0; i < hostNameLen; ++i) hostHash = hostHash * 33 + (unsigned char) hostName[i];
+ MPI_Comm_split(MPI_COMM_WORLD, (int) (hostHash & 0x7fffffff), 0, &hostComm);
+#endif
+ MPI_Comm_split(hostComm, (firstCpu < 0) ? MPI_UNDEFINED : firstCpu * (CPU_SETSIZE + 1) + cpus, 0, &setComm);
+ if (setComm != MPI_COMM_NULL) {
+  MPI_Comm_rank(setComm, &setRank);
+  MPI_Comm_free(&setComm);
+ }
+ MPI_Comm_free(&hostComm);
+
+ if (firstCpu < 0) return -1;
+ if (cpus == 1) return firstCpu;
+
+ int target = setRank % cpus;
+ for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+  if (!CPU_ISSET(cpu, &allowed) || target-- > 0) continue;
+
+  cpu_set_t pinned;
+  CPU_ZERO(&pinned);
+  CPU_SET(cpu, &pinned);
+  if (sched_setaffinity(0, sizeof(pinned), &pinned) != 0) return -1;
+  return cpu;
+ }
+#endif
+ return -1;
+}
+
+// Size of an arena rounded up to whole huge pages.
+num arenaSize(num bytes) {
+ if (bytes == 0) bytes = 1;
+ return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+// Allocates zeroed memory for big per-node buffers, backed by huge pages. Pages are not touched here,
+// they are placed on the NUMA node of the pinned core that writes them first. Returns NULL on failure.
+void *allocateArena(num bytes) {
+ void *arena = MAP_FAILED;
+ if (bytes > MAXIMUM_NUM - 2 * HUGE_PAGE_SIZE) return NULL;
+
+#ifdef HUGE_PAGES_EXPLICIT
+ arena = mmap(NULL, arenaSize(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+ if (arena == MAP_FAILED) {
+  // Transparent huge pages back only whole aligned huge pages, so map one more, align the start
+  // and give back the slack on both sides.
+  char *mapped = (char *) mmap(NULL, arenaSize(bytes) + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) return NULL;
+
+  char *aligned = (char *) (((unsigned long) mapped + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+  if (aligned > mapped) munmap(mapped, aligned - mapped);
+  if (aligned < mapped + HUGE_PAGE_SIZE) munmap(aligned + arenaSize(bytes), mapped + HUGE_PAGE_SIZE - aligned);
+
+  arena = aligned;
+#ifdef MADV_HUGEPAGE
+  madvise(arena, arenaSize(bytes), MADV_HUGEPAGE);
+#endif
+ }
+ return arena;
+}
+
+// Releases memory from allocateArena().
+void freeArena(void *arena, num bytes) {
+ if (arena != NULL) munmap(arena, arenaSize(bytes));
+}
+
+// Upper bound for number of primes in <start; end>, used to preallocate results instead of growing them.
+// Brun-Titchmarsh inequality (Montgomery-Vaughan): pi(x + y) - pi(x) < 2y / ln y for y > 1.
+// Empty segment (more nodes than numbers) gives 0. Result never exceeds what a byte count can hold.
+num primesUpperBound(num start, num end) {
+ if (end < start) return 0LLU;
+
+ // Whole <0; MAXIMUM_NUM> range has 2^64 numbers, one more than `num` can hold.
+ double y = (start == 0 && end == MAXIMUM_NUM) ? 18446744073709551616.0 : (double) (end - start + 1);
+ if (y < 8) return (num) y;
+
+ double bound = 2.0 * y / log(y) + 1;
+ if (bound >= (double) (MAXIMUM_NUM / sizeof(num))) return MAXIMUM_NUM / sizeof(num);
+ return (num) bound;
+}
+
 // Main function.
 int main(int argc, char **argv) {
  int size, rank, nodes;
@@ -122,6 +245,14 @@ int main(int argc, char **argv) {
  START_TIME = MPI_Wtime();
 #endif
 
+#ifdef PIN_NODES
+#ifdef DEBUG
+ printf("(DEBUG) T+%6.2fs: %*d # node: Pinned to core `%d`.\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, pinNode());
+#else
+ pinNode();
+#endif
+#endif
+
  char processorName[MPI_MAX_PROCESSOR_NAME];
  int processorNameLen;
  MPI_Get_processor_name(processorName, &processorNameLen);
@@ -230,11 +361,19 @@ int main(int argc, char **argv) {
   num segmentEnd;
 
   found = 0LLU;
-  std::vector <num> primesList;
 
   MPI_Recv(&segmentStart, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
   MPI_Recv(&segmentEnd, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
+  // Found primes, preallocated for the whole segment.
+  num primesBytes = primesUpperBound(segmentStart, segmentEnd) * sizeof(num);
+  num *primesList = (num *) allocateArena(primesBytes);
+
+  if (primesList == NULL) {
+   printf("   Error: Computational node #%02d can't allocate %llu bytes for results!\n", rank, primesBytes);
+   MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
 #ifdef DEBUG
   printf("(DEBUG) T+%6.2fs: %*d # node: Got segment <%llu; %llu>!\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, segmentStart, segmentEnd);
 #endif
@@ -258,8 +397,8 @@ int main(int argc, char **argv) {
 #endif
 
    if (prime == 1) {
+    primesList[found] = n;
     ++found;
-    primesList.push_back(n);
    }
 
    if (n == MAXIMUM_NUM) break; // Largest possible LLU.
@@ -274,10 +413,12 @@ int main(int argc, char **argv) {
   MPI_Send(&found, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD);
 
   // Send all found prime numbers.
-  for (std::vector<num>::iterator it = primesList.begin(); it != primesList.end(); ++it) {
-   MPI_Send(&(*it), 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD);
+  for (num p = 0LLU; p < found; ++p) {
+   MPI_Send(&primesList[p], 1, MPI_UNSIGNED_LONG_LONG, 0, 0, MPI_COMM_WORLD);
   }
 
+  freeArena(primesList, primesBytes);
+
 #ifdef DEBUG
   printf("(DEBUG) T+%6.2fs: %*d # node: My job is done! Exiting...\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank);
 #endif
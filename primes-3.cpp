@@ -0,0 +1,586 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <math.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <vector>
+
+// Debug mode. Comment next line to disable it. Uncomment to enable.
+//#define DEBUG
+
+#ifdef DEBUG
+#define DEBUG_PADDING 5
+double START_TIME;
+int RANK;
+#endif
+
+//                        ~1.8 * 10 ^ 19 === 2^64 - 1
+// Number can be from 0 to 18,446,744,073,709,551,615
+//                    0    18446744073709551615
+#define MAXIMUM_NUM 18446744073709551615LLU
+
+////////////////////////////////////////////////
+// Input and output files
+
+// File formats.
+//  - FORMAT_BINARY: native 64-bit unsigned integers, one after another.
+//  - FORMAT_TEXT:   one decimal number per line ('\n' or "\r\n" terminated).
+#define FORMAT_BINARY 0
+#define FORMAT_TEXT   1
+
+// Output modes.
+//  - OUTPUT_VERDICTS: one bit per candidate in input order (bit i%8 of byte i/8), 1 = prime.
+//  - OUTPUT_PRIMES:   only the primes, in input order, written in OUTPUT_FORMAT.
+#define OUTPUT_VERDICTS 0
+#define OUTPUT_PRIMES   1
+
+// Default paths. Can be overridden with first and second program argument.
+#define INPUT_FILE  "candidates.txt"
+#define OUTPUT_FILE "primes.txt"
+
+// Change formats and output mode below.
+#define INPUT_FORMAT  FORMAT_TEXT
+#define OUTPUT_MODE   OUTPUT_PRIMES
+#define OUTPUT_FORMAT FORMAT_TEXT
+
+// Longest accepted line of a text file without '\n' (20 digits, '\r' and some spaces), longer lines are malformed.
+// Every node reads that many bytes past its slice to finish its last record.
+#define MAX_LINE_LEN 64
+
+// Maximal number of elements moved by a single collective MPI-IO call (keeps counts in `int` range).
+#define IO_CHUNK (1 << 26)
+
+//
+////////////////////////////////////////////////
+
+////////////////////////////////////////////////
+// Placement
+
+// Pinning nodes to cores. Comment next line to disable it. Uncomment to enable.
+#define PIN_NODES
+
+// Huge pages for big buffers. Transparent huge pages are requested by default.
+// Uncomment next line to use explicitly reserved ones (vm.nr_hugepages), with fallback to transparent.
+//#define HUGE_PAGES_EXPLICIT
+#define HUGE_PAGE_SIZE (2LLU << 20)
+
+//
+////////////////////////////////////////////////
+
+// Num data type.
+typedef unsigned long long int num;
+
+// Primality test.
+bool isPrime(num n) {
+ if (n < 2) return false;
+ if (n < 4) return true;
+ if ((n & 1) == 0) return false;
+ if ((n % 3) == 0) return false;
+
+ num sqrtN = (num) (sqrt(n)) + 1;
+
+ for (num i = 5; i <= sqrtN; i += 6) {
+
+#ifdef DEBUG
+  if (i % 21421333 == 0) {
+   char prog = (char)((i*100)/sqrtN);
+   printf("(DEBUG) T+%6.2fs: %*d # node: Progress %3d%% - testing `%llu` modulo `%llu`\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*RANK+2, RANK, prog, n, i);
+  }
+#endif
+
+  if ((n % i) == 0 || (n % (i + 2)) == 0) return false;
+ }
+ return true;
+}
+
+// Pins calling node to a single core, so it doesn't migrate between cores (and sockets) and memory it
+// touches first stays on its local NUMA node. The launcher may already bind nodes to a socket or NUMA
+// node, so nodes with the same allowed set of cores take consecutive cores of it. A node bound to one
+// core by the launcher is left as it is. Returns the core or -1 if pinning is not possible.
+int pinNode() {
+#ifdef __linux__
+ cpu_set_t allowed;
+ int cpus = 0, firstCpu = -1;
+
+ if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+  cpus = CPU_COUNT(&allowed);
+  for (int cpu = 0; cpu < CPU_SETSIZE && firstCpu < 0; ++cpu) {
+   if (CPU_ISSET(cpu, &allowed)) firstCpu = cpu;
+  }
+ }
+
+ // Nodes of this host with the same allowed set (told apart by its first core and size).
+ MPI_Comm hostComm, setComm;
+ int setRank = 0;
+#if MPI_VERSION >= 3
+ MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &hostComm);
+#else
+ // MPI-2 (e.g. Open MPI 1.6) has no shared memory split, hosts are told apart by a hash of their name.
+ char hostName[MPI_MAX_PROCESSOR_NAME];
+ int hostNameLen;
+ unsigned int hostHash = 5381;
+ MPI_Get_processor_name(hostName, &hostNameLen);
+ for (int i = 0; i < hostNameLen; ++i) hostHash = hostHash * 33 + (unsigned char) hostName[i];
+ MPI_Comm_split(MPI_COMM_WORLD, (int) (hostHash & 0x7fffffff), 0, &hostComm);
+#endif
+ MPI_Comm_split(hostComm, (firstCpu < 0) ? MPI_UNDEFINED : firstCpu * (CPU_SETSIZE + 1) + cpus, 0, &setComm);
+ if (setComm != MPI_COMM_NULL) {
+  MPI_Comm_rank(setComm, &setRank);
+  MPI_Comm_free(&setComm);
+ }
+ MPI_Comm_free(&hostComm);
+
+ if (firstCpu < 0) return -1;
+ if (cpus == 1) return firstCpu;
+
+ int target = setRank % cpus;
+ for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+  if (!CPU_ISSET(cpu, &allowed) || target-- > 0) continue;
+
+  cpu_set_t pinned;
+  CPU_ZERO(&pinned);
+  CPU_SET(cpu, &pinned);
+  if (sched_setaffinity(0, sizeof(pinned), &pinned) != 0) return -1;
+  return cpu;
+ }
+#endif
+ return -1;
+}
+
+// Size of an arena rounded up to whole huge pages.
+num arenaSize(num bytes) {
+ if (bytes == 0) bytes = 1;
+ return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+// Allocates zeroed memory for big per-node buffers, backed by huge pages. Pages are not touched here,
+// they are placed on the NUMA node of the pinned core that writes them first. Returns NULL on failure.
+void *allocateArena(num bytes) {
+ void *arena = MAP_FAILED;
+ if (bytes > MAXIMUM_NUM - 2 * HUGE_PAGE_SIZE) return NULL;
+
+#ifdef HUGE_PAGES_EXPLICIT
+ arena = mmap(NULL, arenaSize(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+ if (arena == MAP_FAILED) {
+  // Transparent huge pages back only whole aligned huge pages, so map one more, align the start
+  // and give back the slack on both sides.
+  char *mapped = (char *) mmap(NULL, arenaSize(bytes) + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) return NULL;
+
+  char *aligned = (char *) (((unsigned long) mapped + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+  if (aligned > mapped) munmap(mapped, aligned - mapped);
+  if (aligned < mapped + HUGE_PAGE_SIZE) munmap(aligned + arenaSize(bytes), mapped + HUGE_PAGE_SIZE - aligned);
+
+  arena = aligned;
+#ifdef MADV_HUGEPAGE
+  madvise(arena, arenaSize(bytes), MADV_HUGEPAGE);
+#endif
+ }
+ return arena;
+}
+
+// Releases memory from allocateArena().
+void freeArena(void *arena, num bytes) {
+ if (arena != NULL) munmap(arena, arenaSize(bytes));
+}
+
+// Collective read of `count` elements at byte `offset`. Split into IO_CHUNK pieces, every node
+// calls MPI_File_read_at_all the same number of times (nodes that are done read 0 elements).
+void readAtAll(MPI_File fh, MPI_Offset offset, void *buf, num count, MPI_Datatype type, int typeSize) {
+ num rounds = (count + IO_CHUNK - 1) / IO_CHUNK;
+ num maxRounds;
+ MPI_Allreduce(&rounds, &maxRounds, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+ for (num r = 0; r < maxRounds; ++r) {
+  num done = r * IO_CHUNK;
+  num part = (done < count) ? count - done : 0LLU;
+  if (part > IO_CHUNK) part = IO_CHUNK;
+  MPI_File_read_at_all(fh, offset + (MPI_Offset) (done * typeSize), (char *) buf + done * typeSize, (int) part, type, MPI_STATUS_IGNORE);
+ }
+}
+
+// Collective write, counterpart of readAtAll().
+void writeAtAll(MPI_File fh, MPI_Offset offset, const void *buf, num count, MPI_Datatype type, int typeSize) {
+ num rounds = (count + IO_CHUNK - 1) / IO_CHUNK;
+ num maxRounds;
+ MPI_Allreduce(&rounds, &maxRounds, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+ for (num r = 0; r < maxRounds; ++r) {
+  num done = r * IO_CHUNK;
+  num part = (done < count) ? count - done : 0LLU;
+  if (part > IO_CHUNK) part = IO_CHUNK;
+  MPI_File_write_at_all(fh, offset + (MPI_Offset) (done * typeSize), (const char *) buf + done * typeSize, (int) part, type, MPI_STATUS_IGNORE);
+ }
+}
+
+// Slice <start; end) of `total` items for given node. First `total % size` nodes get one item more.
+void getSlice(num total, int rank, int size, num *start, num *end) {
+ num base = total / size;
+ num rest = total % size;
+ *start = base * rank + ((num) rank < rest ? (num) rank : rest);
+ *end = *start + base + ((num) rank < rest ? 1LLU : 0LLU);
+}
+
+// Parses text records starting inside <sliceStart; sliceEnd) of the file. Buffer holds bytes
+// from `bufStart` on. A record belongs to the node its first byte falls into, so the node skips
+// the tail of a record started by previous node and finishes its own last record past `sliceEnd`.
+// Candidates are stored to `candidates` and counted in `count`. Returns number of malformed lines (skipped).
+num parseText(const char *buffer, num len, num bufStart, num sliceStart, num sliceEnd, num fileSize, num *candidates, num *count) {
+ num malformed = 0;
+ num pos = 0;
+ *count = 0;
+
+ // Buffer starts one byte before the slice, so a record starting exactly on `sliceStart` is detected.
+ if (sliceStart > 0) {
+  while (pos < len && buffer[pos] != '\n') ++pos;
+  ++pos;
+ }
+
+ while (pos < len && bufStart + pos < sliceEnd) {
+  num value = 0;
+  int digits = 0;
+  bool bad = false;
+  bool ended = false;
+  num lineStart = pos;
+
+  // Whitespace is allowed only before and after the number, not between its digits.
+  while (pos < len && buffer[pos] != '\n') {
+   char c = buffer[pos];
+   if (c >= '0' && c <= '9') {
+    if (ended) bad = true;
+    if (value > (MAXIMUM_NUM - (c - '0')) / 10) bad = true;
+    value = value * 10 + (c - '0');
+    ++digits;
+   } else if (c == ' ' || c == '\t' || c == '\r') {
+    if (digits > 0) ended = true;
+   } else {
+    bad = true;
+   }
+   ++pos;
+  }
+
+  // Checked on every line, so the result doesn't depend on how the file is sliced. A line that runs
+  // past the end of the buffer is always longer than MAX_LINE_LEN and no later record starts here.
+  if (pos - lineStart > MAX_LINE_LEN) {
+   ++malformed;
+   if (pos == len && bufStart + len < fileSize) break;
+  } else if (bad) {
+   ++malformed;
+  } else if (digits > 0) {
+   candidates[(*count)++] = value;
+  }
+  ++pos;
+ }
+
+ return malformed;
+}
+
+// Main function.
+int main(int argc, char **argv) {
+ int size, rank;
+ double time;
+
+ MPI_Init(&argc, &argv);
+
+ MPI_Comm_size(MPI_COMM_WORLD, &size);
+ MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+ const char *inputFile = (argc > 1) ? argv[1] : INPUT_FILE;
+ const char *outputFile = (argc > 2) ? argv[2] : OUTPUT_FILE;
+
+#ifdef DEBUG
+ RANK = rank;
+ START_TIME = MPI_Wtime();
+#endif
+
+#ifdef PIN_NODES
+#ifdef DEBUG
+ printf("(DEBUG) T+%6.2fs: %*d # node: Pinned to core `%d`.\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, pinNode());
+#else
+ pinNode();
+#endif
+#endif
+
+ char processorName[MPI_MAX_PROCESSOR_NAME];
+ int processorNameLen;
+ MPI_Get_processor_name(processorName, &processorNameLen);
+
+ // Processors names.
+ int maxProcessorNameLen;
+ MPI_Reduce(&processorNameLen, &maxProcessorNameLen, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+ maxProcessorNameLen = maxProcessorNameLen + 1;
+ if (rank == 0) {
+  printf("---------------------------------\n   HPC Primality Test (version III)\n---------------------------------\n   Running on %d node(s) (%d computational).\n   Checking candidates from `%s` (%s) for primality!\n   Writing %s to `%s`.\n---------------------------------\n", size, size, inputFile, (INPUT_FORMAT == FORMAT_TEXT) ? "text" : "binary", (OUTPUT_MODE == OUTPUT_PRIMES) ? "primes" : "verdict bits", outputFile);
+  printf("   Available nodes:\n");
+  printf("      - Computational node - rank %02d - runs on: %*s\n", rank, maxProcessorNameLen, processorName);
+
+  for (int i = 1; i < size; ++i) {
+   char name[MPI_MAX_PROCESSOR_NAME] = {};
+   MPI_Recv(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, i, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+   printf("      - Computational node - rank %02d - runs on: %*s\n", i, maxProcessorNameLen, name);
+  }
+
+  printf("---------------------------------\n");
+ } else {
+  MPI_Send(processorName, processorNameLen, MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+ }
+
+ MPI_File inFile;
+ if (MPI_File_open(MPI_COMM_WORLD, inputFile, MPI_MODE_RDONLY, MPI_INFO_NULL, &inFile) != MPI_SUCCESS) {
+  if (rank == 0) printf("   Error: Can't open input file `%s`!\n", inputFile);
+  MPI_Finalize();
+  return 0;
+ }
+
+ MPI_Offset fileSize;
+ MPI_File_get_size(inFile, &fileSize);
+
+ // Start measuring time.
+ MPI_Barrier(MPI_COMM_WORLD);
+ time = MPI_Wtime();
+
+ // Reading candidates. Every node reads only its own slice of the file.
+ // Big buffers are huge page arenas sized up front, first touched by this (pinned) node.
+ num *candidates;
+ num candidatesBytes;
+ num count;
+ num malformed = 0;
+
+#if INPUT_FORMAT == FORMAT_BINARY
+ num total = (num) fileSize / sizeof(num);
+ num sliceStart, sliceEnd;
+
+ if (rank == 0 && (num) fileSize % sizeof(num) != 0) {
+  printf("   Error: Input file size is not a multiple of %d bytes! Ignoring the last %llu byte(s).\n", (int) sizeof(num), (num) fileSize % sizeof(num));
+ }
+
+ getSlice(total, rank, size, &sliceStart, &sliceEnd);
+ count = sliceEnd - sliceStart;
+ candidatesBytes = count * sizeof(num);
+ candidates = (num *) allocateArena(candidatesBytes);
+ if (candidates == NULL) {
+  printf("   Error: Computational node #%02d can't allocate %llu bytes for candidates!\n", rank, candidatesBytes);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+ }
+
+ readAtAll(inFile, (MPI_Offset) (sliceStart * sizeof(num)), candidates, count, MPI_UNSIGNED_LONG_LONG, sizeof(num));
+#else
+ num sliceStart, sliceEnd;
+ getSlice((num) fileSize, rank, size, &sliceStart, &sliceEnd);
+
+ // One byte before the slice (record start detection) and MAX_LINE_LEN bytes after it (last record).
+ num bufStart = (sliceStart > 0) ? sliceStart - 1 : 0LLU;
+ num bufEnd = sliceEnd + MAX_LINE_LEN;
+ if (bufEnd > (num) fileSize) bufEnd = (num) fileSize;
+ if (sliceStart == sliceEnd) bufEnd = bufStart;
+
+ // Every record takes at least two bytes (digit and '\n'), so at most one per two bytes starts in the slice.
+ num bufferBytes = bufEnd - bufStart;
+ candidatesBytes = ((sliceEnd - sliceStart) / 2 + 1) * sizeof(num);
+ char *buffer = (char *) allocateArena(bufferBytes);
+ candidates = (num *) allocateArena(candidatesBytes);
+ if (buffer == NULL || candidates == NULL) {
+  printf("   Error: Computational node #%02d can't allocate %llu bytes for candidates!\n", rank, bufferBytes + candidatesBytes);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+ }
+
+ readAtAll(inFile, (MPI_Offset) bufStart, buffer, bufferBytes, MPI_CHAR, 1);
+
+ malformed = parseText(buffer, bufferBytes, bufStart, sliceStart, sliceEnd, (num) fileSize, candidates, &count);
+ freeArena(buffer, bufferBytes);
+#endif
+
+ MPI_File_close(&inFile);
+
+#ifdef DEBUG
+ printf("(DEBUG) T+%6.2fs: %*d # node: Read %llu candidate(s)!\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, count);
+#endif
+
+ // Index of the first candidate of this node in the whole input (Exscan leaves rank 0 undefined).
+ num firstIndex = 0;
+ MPI_Exscan(&count, &firstIndex, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+ if (rank == 0) firstIndex = 0;
+
+ // Primality tests.
+ num found = 0LLU;
+
+#if OUTPUT_MODE == OUTPUT_VERDICTS
+ // Bits from `firstIndex` on. Bit 0 of local buffer is bit `firstIndex % 8` of file byte `firstIndex / 8`.
+ num shift = firstIndex % 8;
+ num bitsBytes = (shift + count + 7) / 8;
+ unsigned char *bits = (unsigned char *) allocateArena(bitsBytes);
+ if (bits == NULL) {
+  printf("   Error: Computational node #%02d can't allocate %llu bytes for results!\n", rank, bitsBytes);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+ }
+#else
+ // Every candidate can be a prime, so the list never needs to grow.
+ num primesBytes = count * sizeof(num);
+ num *primesList = (num *) allocateArena(primesBytes);
+ if (primesList == NULL) {
+  printf("   Error: Computational node #%02d can't allocate %llu bytes for results!\n", rank, primesBytes);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+ }
+#endif
+
+ for (num c = 0; c < count; ++c) {
+  num n = candidates[c];
+
+#ifdef DEBUG
+  printf("(DEBUG) T+%6.2fs: %*d # node: Checking number `%llu` for primality...\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, n);
+#endif
+
+  char prime;
+  prime = isPrime(n) ? 1 : 0;
+
+#ifdef DEBUG
+  printf("(DEBUG) T+%6.2fs: %*d # node: Calculated status `%d` for number `%llu`.\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, prime, n);
+#endif
+
+  if (prime == 1) {
+#if OUTPUT_MODE == OUTPUT_VERDICTS
+   bits[(shift + c) / 8] |= (unsigned char) (1 << ((shift + c) % 8));
+#else
+   primesList[found] = n;
+#endif
+   ++found;
+  }
+ }
+
+ freeArena(candidates, candidatesBytes);
+
+ // Writing results. Every node writes only its own part of the file.
+ MPI_File outFile;
+ if (MPI_File_open(MPI_COMM_WORLD, outputFile, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &outFile) != MPI_SUCCESS) {
+  if (rank == 0) printf("   Error: Can't open output file `%s`!\n", outputFile);
+  MPI_Finalize();
+  return 0;
+ }
+
+ num totalCandidates;
+ MPI_Allreduce(&count, &totalCandidates, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+#if OUTPUT_MODE == OUTPUT_VERDICTS
+ // Bytes shared with neighbour nodes (first and last one, if not fully owned) are ORed together
+ // and written by the lowest node touching them. Only two bytes per node are exchanged.
+ num partials[4] = { MAXIMUM_NUM, 0LLU, MAXIMUM_NUM, 0LLU };
+ num fullStart = 0, fullEnd = 0;
+
+ if (count > 0) {
+  num firstByte = firstIndex / 8;
+  num lastByte = (firstIndex + count - 1) / 8;
+  bool headPartial = (shift != 0);
+  bool tailPartial = ((firstIndex + count) % 8 != 0);
+
+  fullStart = headPartial ? 1LLU : 0LLU;
+  fullEnd = bitsBytes - ((tailPartial && (lastByte != firstByte || !headPartial)) ? 1LLU : 0LLU);
+  if (fullEnd < fullStart) fullEnd = fullStart;
+
+  if (headPartial) {
+   partials[0] = firstByte;
+   partials[1] = bits[0];
+  }
+  if (tailPartial && (lastByte != firstByte || !headPartial)) {
+   partials[2] = lastByte;
+   partials[3] = bits[bitsBytes - 1];
+  }
+ }
+
+ std::vector <num> allPartials(4 * size);
+ MPI_Allgather(partials, 4, MPI_UNSIGNED_LONG_LONG, allPartials.data(), 4, MPI_UNSIGNED_LONG_LONG, MPI_COMM_WORLD);
+
+ // Nodes without a shared byte to write still join the collective calls, with offset 0 and no data.
+ unsigned char shared[2] = { 0, 0 };
+ int sharedCount[2] = { 0, 0 };
+ MPI_Offset sharedOffset[2] = { 0, 0 };
+
+ for (int p = 0; p < 2; ++p) {
+  num byteIndex = partials[2 * p];
+  if (byteIndex == MAXIMUM_NUM) continue;
+
+  bool owner = true;
+  unsigned char value = 0;
+  for (int r = 0; r < size; ++r) {
+   for (int q = 0; q < 2; ++q) {
+    if (allPartials[4 * r + 2 * q] != byteIndex) continue;
+    value |= (unsigned char) allPartials[4 * r + 2 * q + 1];
+    if (r < rank || (r == rank && q < p)) owner = false;
+   }
+  }
+
+  if (owner) {
+   shared[p] = value;
+   sharedCount[p] = 1;
+   sharedOffset[p] = (MPI_Offset) byteIndex;
+  }
+ }
+
+ num outputSize = (totalCandidates + 7) / 8;
+ MPI_File_set_size(outFile, (MPI_Offset) outputSize);
+
+ writeAtAll(outFile, (MPI_Offset) (firstIndex / 8 + fullStart), bits + fullStart, fullEnd - fullStart, MPI_UNSIGNED_CHAR, 1);
+ MPI_File_write_at_all(outFile, sharedOffset[0], &shared[0], sharedCount[0], MPI_UNSIGNED_CHAR, MPI_STATUS_IGNORE);
+ MPI_File_write_at_all(outFile, sharedOffset[1], &shared[1], sharedCount[1], MPI_UNSIGNED_CHAR, MPI_STATUS_IGNORE);
+#else
+#if OUTPUT_FORMAT == FORMAT_BINARY
+ num outputBytes = found * sizeof(num);
+ const void *output = primesList;
+#else
+ // Up to 20 digits and '\n' per prime, plus '\0' from the last sprintf().
+ num textBytes = found * 21 + 1;
+ char *text = (char *) allocateArena(textBytes);
+ if (text == NULL) {
+  printf("   Error: Computational node #%02d can't allocate %llu bytes for results!\n", rank, textBytes);
+  MPI_Abort(MPI_COMM_WORLD, 1);
+ }
+
+ num outputBytes = 0;
+ for (num p = 0LLU; p < found; ++p) {
+  outputBytes += sprintf(text + outputBytes, "%llu\n", primesList[p]);
+ }
+ const void *output = text;
+#endif
+
+ num outputOffset = 0, outputSize;
+ MPI_Exscan(&outputBytes, &outputOffset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+ if (rank == 0) outputOffset = 0;
+ MPI_Allreduce(&outputBytes, &outputSize, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+ MPI_File_set_size(outFile, (MPI_Offset) outputSize);
+ writeAtAll(outFile, (MPI_Offset) outputOffset, output, outputBytes, MPI_CHAR, 1);
+#endif
+
+ MPI_File_close(&outFile);
+
+#if OUTPUT_MODE == OUTPUT_VERDICTS
+ freeArena(bits, bitsBytes);
+#else
+#if OUTPUT_FORMAT == FORMAT_TEXT
+ freeArena(text, textBytes);
+#endif
+ freeArena(primesList, primesBytes);
+#endif
+
+ // Stop measuring time.
+ time = MPI_Wtime() - time;
+
+#ifdef DEBUG
+ printf("(DEBUG) T+%6.2fs: %*d # node: My job is done! Found %llu prime(s). Exiting...\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, found);
+#endif
+
+ num totalFound, totalMalformed;
+ double maxTime;
+ MPI_Reduce(&found, &totalFound, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+ MPI_Reduce(&malformed, &totalMalformed, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+ MPI_Reduce(&time, &maxTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+ MPI_Finalize();
+
+ if (rank == 0) {
+  if (totalMalformed > 0) printf("   Error: Skipped %llu malformed line(s)!\n", totalMalformed);
+  printf("   Checked %llu number(s). Found %llu prime(s)! It took %.3f seconds!\n---------------------------------\n", totalCandidates, totalFound, maxTime);
+ }
+ return 0;
+}
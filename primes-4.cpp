@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <math.h>
+#include <sched.h>
+
+// Debug mode. Comment next line to disable it. Uncomment to enable.
+//#define DEBUG
+
+#ifdef DEBUG
+#define DEBUG_PADDING 5
+double START_TIME;
+int RANK;
+#endif
+
+//                        ~1.8 * 10 ^ 19 === 2^64 - 1
+// Number can be from 0 to 18,446,744,073,709,551,615
+//                    0    18446744073709551615
+#define MAXIMUM_NUM 18446744073709551615LLU
+
+////////////////////////////////////////////////
+// Test cases
+
+// Change test case below.
+#define TEST_CASE 3
+
+// Test #1: Primes between 0 and 1000  -> pi(1000)  = 168  primes (Time <1 seconds)
+#if TEST_CASE == 1
+#define NUM_START 0LLU
+#define NUM_END   1000LLU
+
+// Test #2: Primes between 0 and 10000 -> pi(10000) = 1229 primes (Time ~2 seconds)
+#elif TEST_CASE == 2
+#define NUM_START 0LLU
+#define NUM_END   10000LLU
+
+// Test #3: Prime gap between 22790428875364879 and 22790428875365903 is 1024 -> 2 primes (Time ~5-6   seconds)
+#elif TEST_CASE == 3
+#define NUM_START 22790428875364879LLU
+#define NUM_END   22790428875365903LLU
+
+// Test #4: Checking 3334 numbers starting from 22790428875364444 to 22790428875367777 for primality -> 56 primes (Time ~29-37 seconds)
+#elif TEST_CASE == 4
+#define NUM_START 22790428875364444LLU
+#define NUM_END   22790428875367777LLU
+
+// Test #5: Primes among last 100 numbers that can be stored in unsigned long long int -> 3 primes (Time ~68-77 seconds)
+#elif TEST_CASE == 5
+#define NUM_START 18446744073709551516LLU
+#define NUM_END   18446744073709551615LLU
+
+// Test #6: Prime gap between 9586724781371233277 and 9586724781371234779 is 1502 -> 2 primes (Time ~145-159 seconds)
+#elif TEST_CASE == 6
+#define NUM_START 9586724781371233277LLU
+#define NUM_END   9586724781371234779LLU
+
+// Custom test case.
+#else
+#define NUM_START 100LLU
+#define NUM_END   200LLU
+
+#endif
+
+////////////////////////////////////////////////
+// Tested edge cases.
+
+//#define NUM_START 18446744073709551614LLU
+//#define NUM_END   18446744073709551614LLU
+
+//#define NUM_START MAXIMUM_NUM
+//#define NUM_END   MAXIMUM_NUM
+
+//#define NUM_START 15LLU
+//#define NUM_END   13LLU
+
+//
+////////////////////////////////////////////////
+
+////////////////////////////////////////////////
+// Placement
+
+// Pinning nodes to cores. Comment next line to disable it. Uncomment to enable.
+#define PIN_NODES
+
+//
+////////////////////////////////////////////////
+
+// Num data type.
+typedef unsigned long long int num;
+
+// Number of divisor pairs (6k + 5, 6k + 7) every node tests alone before the search is split. Most
+// composites have a small factor, so they are rejected without any communication.
+#define LOCAL_PAIRS (1 << 12)
+
+// Number of divisor pairs every node tests between two cancellation checks. Rounds start at
+// ROUND_START and double up to ROUND_SIZE, so a factor found early cancels the search sooner, while
+// long searches (primes) synchronize rarely.
+#define ROUND_START (1 << 10)
+#define ROUND_SIZE  (1 << 18)
+
+// Searches divisors 6k + 5 and 6k + 7 for k in <kStart; kEnd). Returns smallest divisor found or MAXIMUM_NUM.
+num findDivisor(num n, num kStart, num kEnd) {
+ for (num k = kStart; k < kEnd; ++k) {
+  num i = 6 * k + 5;
+  if ((n % i) == 0) return i;
+  if ((n % (i + 2)) == 0) return i + 2;
+ }
+ return MAXIMUM_NUM;
+}
+
+// Primality test. Small divisors are tested by every node alone, the rest of the divisor range of a
+// single number is split among all nodes. In each round node `rank` takes the `rank`-th block of the
+// round, so smaller divisors are tested first by all nodes at once. After every round nodes agree on
+// the smallest divisor found so far and all stop as soon as one exists.
+bool isPrime(num n, int rank, int size) {
+ if (n < 2) return false;
+ if (n < 4) return true;
+ if ((n & 1) == 0) return false;
+ if ((n % 3) == 0) return false;
+
+ num sqrtN = (num) (sqrt(n)) + 1;
+ if (sqrtN < 5) return true;
+
+ num kCount = (sqrtN - 5) / 6 + 1;
+ num kNext = (kCount < LOCAL_PAIRS) ? kCount : (num) LOCAL_PAIRS;
+
+ // Same result on every node, so no need to agree on it.
+ if (findDivisor(n, 0, kNext) != MAXIMUM_NUM) return false;
+
+ num block = ROUND_START;
+
+ while (kNext < kCount) {
+  num kStart = kNext + rank * block;
+  num kEnd = kStart + block;
+  if (kStart > kCount) kStart = kCount;
+  if (kEnd > kCount) kEnd = kCount;
+
+#ifdef DEBUG
+  if (block == ROUND_SIZE && (kNext / ROUND_SIZE / size) % 64 == 0) {
+   char prog = (char)((kNext*100)/kCount);
+   printf("(DEBUG) T+%6.2fs: %*d # node: Progress %3d%% - testing `%llu` modulo <%llu; %llu>\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*RANK+2, RANK, prog, n, 6 * kStart + 5, 6 * kEnd + 1);
+  }
+#endif
+
+  num divisor = findDivisor(n, kStart, kEnd);
+  num smallest;
+  MPI_Allreduce(&divisor, &smallest, 1, MPI_UNSIGNED_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+
+  if (smallest != MAXIMUM_NUM) {
+
+#ifdef DEBUG
+   printf("(DEBUG) T+%6.2fs: %*d # node: Number `%llu` is divisible by `%llu`. Cancelling search...\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*RANK+2, RANK, n, smallest);
+#endif
+
+   return false;
+  }
+
+  kNext += block * size;
+  if (block < ROUND_SIZE) block *= 2;
+ }
+ return true;
+}
+
+// Pins calling node to a single core, so it doesn't migrate between cores (and sockets) and memory it
+// touches first stays on its local NUMA node. The launcher may already bind nodes to a socket or NUMA
+// node, so nodes with the same allowed set of cores take consecutive cores of it. A node bound to one
+// core by the launcher is left as it is. Returns the core or -1 if pinning is not possible.
+int pinNode() {
+#ifdef __linux__
+ cpu_set_t allowed;
+ int cpus = 0, firstCpu = -1;
+
+ if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+  cpus = CPU_COUNT(&allowed);
+  for (int cpu = 0; cpu < CPU_SETSIZE && firstCpu < 0; ++cpu) {
+   if (CPU_ISSET(cpu, &allowed)) firstCpu = cpu;
+  }
+ }
+
+ // Nodes of this host with the same allowed set (told apart by its first core and size).
+ MPI_Comm hostComm, setComm;
+ int setRank = 0;
+#if MPI_VERSION >= 3
+ MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &hostComm);
+#else
+ // MPI-2 (e.g. Open MPI 1.6) has no shared memory split, hosts are told apart by a hash of their name.
+ char hostName[MPI_MAX_PROCESSOR_NAME];
+ int hostNameLen;
+ unsigned int hostHash = 5381;
+ MPI_Get_processor_name(hostName, &hostNameLen);
+ for (int i = 0; i < hostNameLen; ++i) hostHash = hostHash * 33 + (unsigned char) hostName[i];
+ MPI_Comm_split(MPI_COMM_WORLD, (int) (hostHash & 0x7fffffff), 0, &hostComm);
+#endif
+ MPI_Comm_split(hostComm, (firstCpu < 0) ? MPI_UNDEFINED : firstCpu * (CPU_SETSIZE + 1) + cpus, 0, &setComm);
+ if (setComm != MPI_COMM_NULL) {
+  MPI_Comm_rank(setComm, &setRank);
+  MPI_Comm_free(&setComm);
+ }
+ MPI_Comm_free(&hostComm);
+
+ if (firstCpu < 0) return -1;
+ if (cpus == 1) return firstCpu;
+
+ int target = setRank % cpus;
+ for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+  if (!CPU_ISSET(cpu, &allowed) || target-- > 0) continue;
+
+  cpu_set_t pinned;
+  CPU_ZERO(&pinned);
+  CPU_SET(cpu, &pinned);
+  if (sched_setaffinity(0, sizeof(pinned), &pinned) != 0) return -1;
+  return cpu;
+ }
+#endif
+ return -1;
+}
+
+// Main function.
+int main(int argc, char **argv) {
+ int size, rank;
+ num found;
+ double time;
+
+ MPI_Init(&argc, &argv);
+
+ MPI_Comm_size(MPI_COMM_WORLD, &size);
+ MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+#if NUM_START > NUM_END
+ if (rank == 0) printf("   Error: NUM_START can't be bigger than NUM_END!\n"); MPI_Finalize(); return 0;
+#endif
+
+#ifdef DEBUG
+ RANK = rank;
+ START_TIME = MPI_Wtime();
+#endif
+
+#ifdef PIN_NODES
+#ifdef DEBUG
+ printf("(DEBUG) T+%6.2fs: %*d # node: Pinned to core `%d`.\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, pinNode());
+#else
+ pinNode();
+#endif
+#endif
+
+ char processorName[MPI_MAX_PROCESSOR_NAME];
+ int processorNameLen;
+ MPI_Get_processor_name(processorName, &processorNameLen);
+
+ // Processors names.
+ int maxProcessorNameLen;
+ MPI_Reduce(&processorNameLen, &maxProcessorNameLen, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+ maxProcessorNameLen = maxProcessorNameLen + 1;
+ if (rank == 0) {
+  printf("---------------------------------\n   HPC Primality Test (version IV)\n---------------------------------\n   Running on %d node(s) (%d computational).\n   Checking %llu number(s) starting from %llu to %llu for primality!\n---------------------------------\n", size, size, NUM_END - NUM_START + 1, NUM_START, NUM_END);
+  printf("   Available nodes:\n");
+  printf("      - Computational node - rank %02d - runs on: %*s\n", rank, maxProcessorNameLen, processorName);
+
+  for (int i = 1; i < size; ++i) {
+   char name[MPI_MAX_PROCESSOR_NAME] = {};
+   MPI_Recv(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, i, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+   printf("      - Computational node - rank %02d - runs on: %*s\n", i, maxProcessorNameLen, name);
+  }
+
+  printf("---------------------------------\n");
+ } else {
+  MPI_Send(processorName, processorNameLen, MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+ }
+
+ // All nodes walk through the same numbers and share the work on each of them.
+ num n = NUM_START;
+ found = 0LLU;
+
+ if (n < 2) n = 2;
+ if ((n > 2) && ((n & 1) == 0)) ++n;
+
+ // Start measuring time.
+ MPI_Barrier(MPI_COMM_WORLD);
+ time = MPI_Wtime();
+
+ while (n <= NUM_END) {
+
+#ifdef DEBUG
+  printf("(DEBUG) T+%6.2fs: %*d # node: Checking number `%llu` for primality...\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank, n);
+#endif
+
+  char prime;
+  prime = isPrime(n, rank, size) ? 1 : 0;
+
+  if (prime == 1) {
+   ++found;
+   if (rank == 0) printf("   Computational nodes found prime:\t%llu\n", n);
+  }
+
+  if (n == MAXIMUM_NUM) break; // Largest possible LLU.
+  if (n < 3) n += 1; else n += 2;
+ }
+
+ // Stop measuring time.
+ time = MPI_Wtime() - time;
+
+#ifdef DEBUG
+ printf("(DEBUG) T+%6.2fs: %*d # node: The search is over!\n", (MPI_Wtime()-START_TIME), DEBUG_PADDING*rank+2, rank);
+#endif
+
+ MPI_Finalize();
+
+ if (rank == 0) {
+  printf("---------------------------------\n   Found %llu prime(s)! It took %.3f seconds!\n---------------------------------\n", found, time);
+ }
+ return 0;
+}